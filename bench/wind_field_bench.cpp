@@ -0,0 +1,51 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../src/wind_field.hpp"
+
+// measures how long it takes to advance a wind field and to sample it at 1M points, per frame
+int main() {
+#if defined(__GNUC__) && !defined(__OPTIMIZE__)
+    std::cerr << "warning: the benchmark was built without optimizations, its numbers are meaningless" << std::endl;
+#endif
+
+    constexpr auto num_samples = 1 << 20;
+    constexpr auto num_frames  = 60;
+    constexpr auto time_step   = 1.0f / 60.0f;
+
+    WindField wind{{ -50.0f, -50.0f, -50.0f }, { 100.0f, 100.0f, 100.0f }, { 64, 64, 64 }, { 0.0f, 0.0f, -2.0f }, 0.75f };
+
+    // random points spread over the whole field, slightly past its bounds to exercise the clamping too
+    WindSamples samples;
+    samples.resize(num_samples);
+    std::mt19937                          rng{ 42 };
+    std::uniform_real_distribution<float> coordinate{ -55.0f, 55.0f };
+    for (auto i = 0; i < num_samples; i++) {
+        samples.x[i] = coordinate(rng);
+        samples.y[i] = coordinate(rng);
+        samples.z[i] = coordinate(rng);
+    }
+
+    std::chrono::duration<double, std::milli> update_time{}, sample_time{};
+    // accumulate the samples, so the work can't be optimized away
+    auto                                      checksum = 0.0f;
+    for (auto frame = 0; frame < num_frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        wind.update(time_step);
+        auto middle = std::chrono::steady_clock::now();
+        wind.sample(samples);
+        auto end = std::chrono::steady_clock::now();
+
+        update_time += middle - start;
+        sample_time += end - middle;
+        checksum += samples.vx[frame] + samples.vy[frame] + samples.vz[frame];
+    }
+
+    std::cout << "wind field " << wind.resolution.x << "x" << wind.resolution.y << "x" << wind.resolution.z
+              << " on " << wind.num_threads << " threads, " << num_samples << " samples per frame" << std::endl;
+    std::cout << "update: " << update_time.count() / num_frames << " ms/frame" << std::endl;
+    std::cout << "sample: " << sample_time.count() / num_frames << " ms/frame ("
+              << sample_time.count() * 1e6 / ((double) num_frames * num_samples) << " ns/sample)" << std::endl;
+    std::cout << "checksum: " << checksum << std::endl;
+    return 0;
+}
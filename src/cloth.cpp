@@ -1,20 +1,54 @@
+#include <algorithm>
 #include <cstdio>
+#include <utility>
 #include "cloth.hpp"
 #include "vertex.hpp"
 
-Cloth::Cloth(glm::vec3 _position, float width, float height, int _num_particles_width, int _num_particles_height) :
+Cloth::Cloth(glm::vec3 _position, float _width, float _height, int _num_particles_width, int _num_particles_height) :
         position{ _position },
-        num_particles_width{ _num_particles_width },
-        num_particles_height{ _num_particles_height } {
+        width{ _width },
+        height{ _height } {
+    build(_num_particles_width, _num_particles_height);
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+
+    glBindVertexArray(vao);
+    upload();
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, position));
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, normal));
+
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, color));
+
+    glBindVertexArray(0);
+}
+
+void Cloth::build(int _num_particles_width, int _num_particles_height) {
+    num_particles_width  = _num_particles_width;
+    num_particles_height = _num_particles_height;
+
+    // the constraints reference the particles, so they must go first
+    constraints.clear();
+    particles.clear();
+    vertices.clear();
+    indices.clear();
+
     particles.reserve(num_particles_width * num_particles_height);
     vertices.reserve(num_particles_width * num_particles_height);
     indices.reserve((num_particles_width - 1) * (num_particles_height - 1) * 6);
 
     for (auto y = 0; y < num_particles_height; y++) {
         for (auto x = 0; x < num_particles_width; x++) {
-            // create the particles in a rectangular mesh
+            // create the particles in a rectangular mesh. the first and last particles sit on the edges of the cloth,
+            // so it has the same size at every resolution
             particles.emplace_back(
-                    glm::vec3{ x * width / num_particles_width, y * -height / num_particles_height, 0.0f } + position);
+                    glm::vec3{ x * width / (num_particles_width - 1), y * -height / (num_particles_height - 1), 0.0f } + position);
 
             // for each new particle, create its corresponding vertex, with no normal and some color
             vertices.push_back({ particles.back().position, {}, { x % 2 == 0, 0.0f, x % 2 != 0 }});
@@ -97,16 +131,16 @@ Cloth::Cloth(glm::vec3 _position, float width, float height, int _num_particles_
         }
     }
 
-    // make the upper corners immovable
-    for (auto i = 0; i < 3; i++) {
+    // make the upper corners immovable. the pinned strip is measured in distance rather than particles, so it has
+    // the same size at every resolution. the corner particles themselves are always pinned
+    auto spacing = width / (num_particles_width - 1);
+    for (auto i = 0; i < num_particles_width && (i == 0 || i * spacing <= pinned_width); i++) {
         get_particle(i, 0).movable                           = false;
         get_particle(num_particles_width - 1 - i, 0).movable = false;
     }
+}
 
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ebo);
-
+void Cloth::upload() {
     glBindVertexArray(vao);
     // bind the VBO and allocate enough data for the vertices, but don't store anything in the buffer yet
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
@@ -115,16 +149,54 @@ Cloth::Cloth(glm::vec3 _position, float width, float height, int _num_particles_
     // bind the EBO and store the computed indices
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+}
 
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, position));
+void Cloth::set_resolution(int _num_particles_width, int _num_particles_height) {
+    if (_num_particles_width == num_particles_width && _num_particles_height == num_particles_height) {
+        return;
+    }
 
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, normal));
+    // keep the old particles around, so the new ones can be sampled from them
+    auto old_particles            = std::move(particles);
+    auto old_num_particles_width  = num_particles_width;
+    auto old_num_particles_height = num_particles_height;
 
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, color));
+    // the new particles are first created at rest, so that the constraints get rest distances matching the new spacing
+    build(_num_particles_width, _num_particles_height);
 
+    // bilinearly interpolates a member of the old particles at the normalized grid coordinates (u, v)
+    auto sample = [&](float u, float v, glm::vec3 Particle::* member) {
+        auto fx = u * (old_num_particles_width - 1);
+        auto fy = v * (old_num_particles_height - 1);
+        auto x0 = std::min((int) fx, old_num_particles_width - 2);
+        auto y0 = std::min((int) fy, old_num_particles_height - 2);
+        auto tx = fx - x0;
+        auto ty = fy - y0;
+
+        auto& p00 = old_particles[(y0 + 0) * old_num_particles_width + x0 + 0].*member;
+        auto& p10 = old_particles[(y0 + 0) * old_num_particles_width + x0 + 1].*member;
+        auto& p01 = old_particles[(y0 + 1) * old_num_particles_width + x0 + 0].*member;
+        auto& p11 = old_particles[(y0 + 1) * old_num_particles_width + x0 + 1].*member;
+        return glm::mix(glm::mix(p00, p10, tx), glm::mix(p01, p11, tx), ty);
+    };
+
+    // carry over the deformation of the cloth. since Verlet integration stores the velocity implicitly as the
+    // difference between the current and the old position, sampling both of them carries over the velocity too
+    for (auto y = 0; y < num_particles_height; y++) {
+        for (auto x = 0; x < num_particles_width; x++) {
+            auto& particle = get_particle(x, y);
+            // the immovable particles stay where they were built. the constraints pull their neighbours along
+            if (!particle.movable) {
+                continue;
+            }
+            auto u = (float) x / (num_particles_width - 1);
+            auto v = (float) y / (num_particles_height - 1);
+            particle.position     = sample(u, v, &Particle::position);
+            particle.old_position = sample(u, v, &Particle::old_position);
+        }
+    }
+
+    upload();
     glBindVertexArray(0);
 }
 
@@ -209,6 +281,47 @@ void Cloth::add_wind(glm::vec3 force) {
     }
 }
 
+void Cloth::add_wind(const WindField& field, float strength) {
+    wind_samples.resize((num_particles_width - 1) * (num_particles_height - 1) * 2);
+
+    // gather the centers of the triangles, in the same order as they are visited below
+    auto i = 0;
+    for (auto x = 0; x < num_particles_width - 1; x++) {
+        for (auto y = 0; y < num_particles_height - 1; y++) {
+            auto& p00   = get_particle(x + 0, y + 0).position;
+            auto& p10   = get_particle(x + 1, y + 0).position;
+            auto& p01   = get_particle(x + 0, y + 1).position;
+            auto& p11   = get_particle(x + 1, y + 1).position;
+            auto center = (p10 + p00 + p01) / 3.0f;
+            wind_samples.x[i] = center.x;
+            wind_samples.y[i] = center.y;
+            wind_samples.z[i] = center.z;
+            i++;
+
+            center = (p11 + p10 + p01) / 3.0f;
+            wind_samples.x[i] = center.x;
+            wind_samples.y[i] = center.y;
+            wind_samples.z[i] = center.z;
+            i++;
+        }
+    }
+
+    field.sample(wind_samples);
+
+    i = 0;
+    for (auto x = 0; x < num_particles_width - 1; x++) {
+        for (auto y = 0; y < num_particles_height - 1; y++) {
+            auto force = glm::vec3{ wind_samples.vx[i], wind_samples.vy[i], wind_samples.vz[i] } * strength;
+            add_wind(get_particle(x + 1, y), get_particle(x, y), get_particle(x, y + 1), force);
+            i++;
+
+            force = glm::vec3{ wind_samples.vx[i], wind_samples.vy[i], wind_samples.vz[i] } * strength;
+            add_wind(get_particle(x + 1, y + 1), get_particle(x + 1, y), get_particle(x, y + 1), force);
+            i++;
+        }
+    }
+}
+
 void Cloth::ball_collision(const Ball& ball) {
     for (auto& particle : particles) {
         auto v = particle.position - ball.position;
@@ -7,9 +7,20 @@
 #include "constraint.hpp"
 #include "state.hpp"
 #include "ball.hpp"
+#include "wind_field.hpp"
 
 struct Cloth {
-    Cloth(glm::vec3 _position, float width, float height, int _num_particles_width, int _num_particles_height);
+    Cloth(glm::vec3 _position, float _width, float _height, int _num_particles_width, int _num_particles_height);
+
+    // creates the particles, constraints, vertices and indices for the given resolution, with the cloth at rest
+    void build(int _num_particles_width, int _num_particles_height);
+
+    // (re)allocates the VBO and stores the indices in the EBO. leaves the VAO bound
+    void upload();
+
+    // rebuilds the cloth with a different number of particles, carrying over the current positions and velocities
+    // the rest distances of the constraints are recomputed from the new particle spacing
+    void set_resolution(int _num_particles_width, int _num_particles_height);
 
     // satisfy each constraint and update particles
     void update();
@@ -30,6 +41,10 @@ struct Cloth {
     // adds wind force to the entire cloth
     void add_wind(glm::vec3 force);
 
+    // adds wind force to the entire cloth, sampling the wind field at the center of each triangle in a single batch
+    // the sampled velocities are scaled by strength to get the wind force
+    void add_wind(const WindField& field, float strength);
+
     // updates the particles such that the cloth does not collide with the ball
     void ball_collision(const Ball& ball);
 
@@ -37,6 +52,9 @@ struct Cloth {
     int num_particles_height;
 
     glm::vec3 position;
+    // the size of the cloth at rest, regardless of its resolution
+    float     width;
+    float     height;
 
     std::vector<Particle>   particles;
     std::vector<Constraint> constraints;
@@ -45,6 +63,11 @@ struct Cloth {
     std::vector<GLuint> indices;
     GLuint              vao{}, vbo{}, ebo{};
 
+    // the centers of the triangles and the wind sampled there, kept around to avoid reallocating them every frame
+    WindSamples wind_samples;
+
     // number of times to run constraint satisfaction per update
     static constexpr unsigned int constraint_iterations = 30;
+    // distance from each upper corner, at rest, within which the particles are immovable
+    static constexpr float        pinned_width          = 0.5f;
 };
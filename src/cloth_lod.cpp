@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include "cloth_lod.hpp"
+
+// the center of the cloth, used for measuring its distance to the camera
+static glm::vec3 cloth_center(Cloth& cloth) {
+    return cloth.get_particle(cloth.num_particles_width / 2, cloth.num_particles_height / 2).position;
+}
+
+ClothLod::ClothLod(Cloth& _cloth, std::vector<glm::ivec2> _levels, std::vector<float> _switch_distances) :
+        cloth{ _cloth },
+        levels{ std::move(_levels) },
+        switch_distances{ std::move(_switch_distances) },
+        level{ 0 },
+        // allow the first switch right away
+        frames_since_switch{ min_frames_between_switches },
+        // a rough initial guess, it gets refined after the first update
+        ms_per_constraint{ 0.00005f } {
+    if (levels.empty() || levels.size() != switch_distances.size()) {
+        throw std::invalid_argument{ "a cloth LOD needs one switch distance for each of its levels, and at least one level" };
+    }
+    cloth.set_resolution(levels[level].x, levels[level].y);
+}
+
+int ClothLod::level_for_distance(glm::vec3 camera) const {
+    auto distance = glm::distance(camera, cloth_center(cloth));
+
+    // the current level is kept until the distance leaves its range by more than the hysteresis, so a cloth moving
+    // around a switch distance doesn't flip between two levels every frame
+    auto lower = level > 0 ? switch_distances[level] - hysteresis : -std::numeric_limits<float>::infinity();
+    auto upper = level + 1 < levels.size() ? switch_distances[level + 1] + hysteresis : std::numeric_limits<float>::infinity();
+    if (distance >= lower && distance < upper) {
+        return level;
+    }
+
+    auto result = 0;
+    // the switch distances are increasing, so the last one we passed gives the level
+    for (auto i = 0; i < levels.size(); i++) {
+        if (distance >= switch_distances[i]) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+void ClothLod::set_level(int _level) {
+    // each switch rebuilds the cloth, so don't do it more often than needed
+    if (_level == level || frames_since_switch < min_frames_between_switches) {
+        return;
+    }
+    level               = _level;
+    frames_since_switch = 0;
+    cloth.set_resolution(levels[level].x, levels[level].y);
+}
+
+void ClothLod::record_cost(float elapsed_ms) {
+    frames_since_switch++;
+
+    auto measured = elapsed_ms / cloth.constraints.size();
+    ms_per_constraint += (measured - ms_per_constraint) * cost_smoothing;
+}
+
+float ClothLod::estimated_cost(int _level) const {
+    return ms_per_constraint * constraint_count(levels[_level]);
+}
+
+int ClothLod::constraint_count(glm::ivec2 resolution) {
+    auto w = resolution.x;
+    auto h = resolution.y;
+    // the structural, shear and bending constraints created by Cloth::build. this has to match it, since it is
+    // used for the levels the cloth isn't currently built at
+    auto structural = (w - 1) * h + w * (h - 1);
+    auto shear      = 2 * (w - 1) * (h - 1);
+    auto bending    = std::max(w - 2, 0) * h + w * std::max(h - 2, 0) + 2 * std::max(w - 2, 0) * std::max(h - 2, 0);
+    return structural + shear + bending;
+}
+
+LodBudget::LodBudget(float _budget_ms) : budget_ms{ _budget_ms } {
+}
+
+void LodBudget::add(ClothLod& lod) {
+    lods.push_back(&lod);
+}
+
+void LodBudget::select(glm::vec3 camera) {
+    std::vector<int>   chosen(lods.size());
+    std::vector<float> distances(lods.size());
+    auto               total = 0.0f;
+    for (auto i = 0; i < lods.size(); i++) {
+        chosen[i]    = lods[i]->level_for_distance(camera);
+        distances[i] = glm::distance(camera, cloth_center(lods[i]->cloth));
+        total += lods[i]->estimated_cost(chosen[i]);
+    }
+
+    // visit the cloths from the furthest to the closest, since the furthest ones show the least detail
+    std::vector<int> order(lods.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return distances[a] > distances[b]; });
+
+    // coarsen one level at a time, going around the cloths, so that the detail is lost evenly
+    auto coarsened = true;
+    while (total > budget_ms && coarsened) {
+        coarsened = false;
+        for (auto i : order) {
+            if (total <= budget_ms) {
+                break;
+            }
+            if (chosen[i] + 1 < lods[i]->levels.size()) {
+                total -= lods[i]->estimated_cost(chosen[i]);
+                chosen[i]++;
+                total += lods[i]->estimated_cost(chosen[i]);
+                coarsened = true;
+            }
+        }
+    }
+
+    for (auto i = 0; i < lods.size(); i++) {
+        lods[i]->set_level(chosen[i]);
+    }
+}
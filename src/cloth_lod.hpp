@@ -0,0 +1,80 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <chrono>
+#include <vector>
+#include "cloth.hpp"
+
+// a hierarchy of resolutions for a cloth, from the finest to the coarsest, between which the cloth can be switched
+struct ClothLod {
+    // throws std::invalid_argument if there are no levels, or not exactly one switch distance per level
+    ClothLod(Cloth& _cloth, std::vector<glm::ivec2> _levels, std::vector<float> _switch_distances);
+
+    // the level that should be used when the camera is at the given position. near a switch distance, the current
+    // level is kept until the camera moves past the hysteresis band
+    int level_for_distance(glm::vec3 camera) const;
+
+    // switches the cloth to the given level, if it isn't already there and it hasn't switched too recently
+    void set_level(int _level);
+
+    // runs one simulation step of the cloth and measures how long it took, refining the cost estimate
+    // the step is given the cloth and should do everything done to it in a frame: forces, wind, collisions, the
+    // update itself and drawing, so that the estimate covers the whole cost of the cloth
+    template<typename Step>
+    void update(Step&& step) {
+        auto start = std::chrono::steady_clock::now();
+        step(cloth);
+        auto end   = std::chrono::steady_clock::now();
+        record_cost(std::chrono::duration<float, std::milli>(end - start).count());
+    }
+
+    // refines the cost estimate with the measured duration of a whole step at the current level
+    void record_cost(float elapsed_ms);
+
+    // the estimated time a whole step of the cloth would take at the given level, in milliseconds
+    float estimated_cost(int _level) const;
+
+    // the number of constraints Cloth::build creates for the given number of particles
+    static int constraint_count(glm::ivec2 resolution);
+
+    Cloth& cloth;
+    // the number of particles in width and height for each level, level 0 being the finest
+    std::vector<glm::ivec2> levels;
+    // the camera distance from which each level starts being used. the first one should be 0
+    std::vector<float>      switch_distances;
+    int                     level;
+    int                     frames_since_switch;
+
+    // running estimate of the time a whole step takes per constraint, in milliseconds. the constraints dominate the
+    // cost and the rest of the step grows with the number of particles, so the count of constraints scales it well
+    float ms_per_constraint;
+
+    // how much a new measurement weighs in the cost estimate
+    static constexpr float cost_smoothing              = 0.1f;
+    // how far past a switch distance the camera has to go before the level changes
+    static constexpr float hysteresis                  = 2.0f;
+    // the minimum number of updates between two switches
+    static constexpr int   min_frames_between_switches = 30;
+};
+
+// picks the levels of several cloths such that the total time spent simulating and drawing them stays under a budget
+struct LodBudget {
+    explicit LodBudget(float _budget_ms);
+
+    void add(ClothLod& lod);
+
+    // starts from the levels given by the distance to the camera, then coarsens the cloths furthest away from the
+    // camera until the estimated total cost fits in the budget or every cloth is at its coarsest level
+    void select(glm::vec3 camera);
+
+    // runs the step on each of the cloths, see ClothLod::update
+    template<typename Step>
+    void update(Step&& step) {
+        for (auto lod : lods) {
+            lod->update(step);
+        }
+    }
+
+    float                  budget_ms;
+    std::vector<ClothLod*> lods;
+};
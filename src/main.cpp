@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include "cloth.hpp"
+#include "cloth_lod.hpp"
 #include "shader.hpp"
 
 constexpr int WIDTH  = 1280;
@@ -39,6 +40,14 @@ int main() {
     glfwSetKeyCallback(window, key_callback);
 
     Cloth cloth{{ -7.5f, 5.0f, 0.0f }, 15, 10, 75, 50 };
+    // the cloth switches to coarser resolutions when it is far away, or when updating it takes too long
+    ClothLod  cloth_lod{ cloth, {{ 75, 50 }, { 45, 30 }, { 30, 20 }}, { 0.0f, 40.0f, 80.0f }};
+    LodBudget lod_budget{ 8.0f };
+    lod_budget.add(cloth_lod);
+
+    // a turbulent wind blowing into the screen, covering the space in which the cloth can move
+    WindField wind{{ -10.0f, -8.0f, -6.0f }, { 20.0f, 16.0f, 12.0f }, { 24, 20, 16 }, { 0.0f, 0.0f, -2.0f }, 0.75f };
+
     Ball  ball{{ 0.0f, 0.0f, 1.0f }, 2.0f, { 0.0f, 1.0f, 0.0f }};
 
     Shader shader{ "shaders/vertex.glsl", "shaders/fragment.glsl" };
@@ -46,25 +55,31 @@ int main() {
 
     // the camera doesn't move, so we can compute the matrices outside the loop
     auto proj = glm::perspective(glm::radians(45.0f), (float) WIDTH / HEIGHT, 0.1f, 1000.0f);
-    auto view = glm::lookAt(glm::vec3{ -10.0f, 0.0f, 20.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+    auto camera = glm::vec3{ -10.0f, 0.0f, 20.0f };
+    auto view   = glm::lookAt(camera, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
 
     shader.set("light_position", view * glm::vec4{ 0.0f, 5.0f, 20.0f, 1.0f });
 
     glEnable(GL_DEPTH_TEST);
+    auto last_time = glfwGetTime();
     while (!glfwWindowShouldClose(window)) {
+        auto current_time = glfwGetTime();
+        auto time_step    = (float) (current_time - last_time);
+        last_time = current_time;
+
         glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // update the ball
         ball.update(state);
-
-        // add some arbitrary gravity to the cloth, collide with the ball and update the cloth
-        cloth.add_force({ 0.0f, -0.09f, 0.0f });
-        cloth.ball_collision(ball);
+        // the wind is only sampled while space is held, so there is no need to advance it otherwise. it just picks up
+        // where it left off the next time
         if (state.keys[Keys::space]) {
-            cloth.add_wind({ 0.0f, 0.0f, -0.01f });
+            wind.update(time_step);
         }
-        cloth.update();
+
+        // pick the resolution of the cloth before any forces are applied to it
+        lod_budget.select(camera);
 
         // draw the ball
         glm::mat4 model{ 1.0f };
@@ -75,14 +90,23 @@ int main() {
         shader.set("normal_matrix", glm::transpose(glm::inverse(mv)));
         ball.draw();
 
-        // draw the cloth
-        // we don't translate to the cloth's position because its particles are already moved to world coordinates in order to interact with stuff
-        model = glm::mat4{ 1.0f };
-        mv    = view * model;
-        shader.set("mv", mv);
-        shader.set("mvp", proj * mv);
-        shader.set("normal_matrix", glm::transpose(glm::inverse(mv)));
-        cloth.draw();
+        // simulate and draw the cloth. it's all done in one step, so the LOD budget accounts for all of it
+        lod_budget.update([&](Cloth& lod_cloth) {
+            // add some arbitrary gravity to the cloth, collide with the ball and update the cloth
+            lod_cloth.add_force({ 0.0f, -0.09f, 0.0f });
+            lod_cloth.ball_collision(ball);
+            if (state.keys[Keys::space]) {
+                lod_cloth.add_wind(wind, 0.005f);
+            }
+            lod_cloth.update();
+
+            // we don't translate to the cloth's position because its particles are already moved to world coordinates in order to interact with stuff
+            mv = view * glm::mat4{ 1.0f };
+            shader.set("mv", mv);
+            shader.set("mvp", proj * mv);
+            shader.set("normal_matrix", glm::transpose(glm::inverse(mv)));
+            lod_cloth.draw();
+        });
 
         glfwSwapBuffers(window);
         glfwPollEvents();
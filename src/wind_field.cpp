@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include "wind_field.hpp"
+
+// forces a function to be inlined, on the compilers that support it
+#if defined(__GNUC__)
+#define ALWAYS_INLINE __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE
+#endif
+
+// hashes a lattice point into a pseudo random value in [-1, 1]
+static float lattice_value(int x, int y, int z, std::uint32_t seed) {
+    auto h = (std::uint32_t) x * 73856093u ^ (std::uint32_t) y * 19349663u ^ (std::uint32_t) z * 83492791u ^ seed;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return (float) (h & 0xffffu) / 32767.5f - 1.0f;
+}
+
+// smoothly interpolated value noise in [-1, 1]
+static float value_noise(glm::vec3 point, std::uint32_t seed) {
+    auto cell = glm::floor(point);
+    auto t    = point - cell;
+    // smoothstep, so that the noise has no visible creases along the lattice
+    t = t * t * (glm::vec3{ 3.0f } - 2.0f * t);
+
+    auto x = (int) cell.x;
+    auto y = (int) cell.y;
+    auto z = (int) cell.z;
+
+    auto x00 = glm::mix(lattice_value(x, y + 0, z + 0, seed), lattice_value(x + 1, y + 0, z + 0, seed), t.x);
+    auto x10 = glm::mix(lattice_value(x, y + 1, z + 0, seed), lattice_value(x + 1, y + 1, z + 0, seed), t.x);
+    auto x01 = glm::mix(lattice_value(x, y + 0, z + 1, seed), lattice_value(x + 1, y + 0, z + 1, seed), t.x);
+    auto x11 = glm::mix(lattice_value(x, y + 1, z + 1, seed), lattice_value(x + 1, y + 1, z + 1, seed), t.x);
+    return glm::mix(glm::mix(x00, x10, t.y), glm::mix(x01, x11, t.y), t.z);
+}
+
+// interpolates one component of the field between the 8 nodes of a cell
+// i is the index of the cell's lowest node, and sy, sz are the index strides along y and z
+ALWAYS_INLINE static inline float trilinear(const float* field, int i, int sy, int sz, float tx, float ty, float tz) {
+    auto c00 = field[i] + (field[i + 1] - field[i]) * tx;
+    auto c10 = field[i + sy] + (field[i + sy + 1] - field[i + sy]) * tx;
+    auto c01 = field[i + sz] + (field[i + sz + 1] - field[i + sz]) * tx;
+    auto c11 = field[i + sy + sz] + (field[i + sy + sz + 1] - field[i + sy + sz]) * tx;
+    auto c0  = c00 + (c10 - c00) * ty;
+    auto c1  = c01 + (c11 - c01) * ty;
+    return c0 + (c1 - c0) * tz;
+}
+
+// trilinearly interpolates the field at n points, see WindField::sample
+// the arrays are function parameters marked as not aliasing each other, and everything the loop needs is copied into
+// locals, so the compiler doesn't have to assume that the stores to the outputs change the inputs. the clamping is
+// written with plain comparisons because std::min and std::max return references. all of this lets the loop vectorize
+static void trilinear_batch(const float* __restrict px, const float* __restrict py, const float* __restrict pz,
+                            const float* __restrict fx, const float* __restrict fy, const float* __restrict fz,
+                            float* __restrict out_x, float* __restrict out_y, float* __restrict out_z, std::size_t n,
+                            glm::vec3 origin, glm::vec3 spacing, glm::ivec3 resolution) {
+    const auto origin_x = origin.x;
+    const auto origin_y = origin.y;
+    const auto origin_z = origin.z;
+    const auto scale_x  = 1.0f / spacing.x;
+    const auto scale_y  = 1.0f / spacing.y;
+    const auto scale_z  = 1.0f / spacing.z;
+    const auto max_x    = resolution.x - 1.0f;
+    const auto max_y    = resolution.y - 1.0f;
+    const auto max_z    = resolution.z - 1.0f;
+    const auto last_x   = resolution.x - 2;
+    const auto last_y   = resolution.y - 2;
+    const auto last_z   = resolution.z - 2;
+    const auto sy       = resolution.x;
+    const auto sz       = resolution.x * resolution.y;
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC ivdep
+#endif
+    for (std::size_t i = 0; i < n; i++) {
+        // grid coordinates of the point, clamped to the box
+        auto gx = (px[i] - origin_x) * scale_x;
+        auto gy = (py[i] - origin_y) * scale_y;
+        auto gz = (pz[i] - origin_z) * scale_z;
+        gx = gx < 0.0f ? 0.0f : gx > max_x ? max_x : gx;
+        gy = gy < 0.0f ? 0.0f : gy > max_y ? max_y : gy;
+        gz = gz < 0.0f ? 0.0f : gz > max_z ? max_z : gz;
+
+        // the last node on each axis belongs to the cell before it
+        auto ix = (int) gx;
+        auto iy = (int) gy;
+        auto iz = (int) gz;
+        ix = ix > last_x ? last_x : ix;
+        iy = iy > last_y ? last_y : iy;
+        iz = iz > last_z ? last_z : iz;
+
+        auto tx   = gx - ix;
+        auto ty   = gy - iy;
+        auto tz   = gz - iz;
+        auto cell = ix + iy * sy + iz * sz;
+
+        out_x[i] = trilinear(fx, cell, sy, sz, tx, ty, tz);
+        out_y[i] = trilinear(fy, cell, sy, sz, tx, ty, tz);
+        out_z[i] = trilinear(fz, cell, sy, sz, tx, ty, tz);
+    }
+}
+
+void WindSamples::resize(std::size_t size) {
+    x.resize(size);
+    y.resize(size);
+    z.resize(size);
+    vx.resize(size);
+    vy.resize(size);
+    vz.resize(size);
+}
+
+std::size_t WindSamples::size() const {
+    return x.size();
+}
+
+WindField::WindField(glm::vec3 _origin, glm::vec3 _size, glm::ivec3 _resolution, glm::vec3 _direction,
+                     float _turbulence, unsigned int _num_threads) :
+        origin{ _origin },
+        size{ _size },
+        // we need at least two nodes on each axis to interpolate between them
+        resolution{ std::max(_resolution.x, 2), std::max(_resolution.y, 2), std::max(_resolution.z, 2) },
+        direction{ _direction },
+        turbulence{ _turbulence },
+        time{ 0.0f },
+        num_threads{ _num_threads != 0 ? _num_threads : std::max(std::thread::hardware_concurrency(), 1u) },
+        generation{ 0 },
+        busy_workers{ 0 },
+        current_time_step{ 0.0f },
+        stopping{ false } {
+    spacing = size / glm::vec3{ resolution.x - 1.0f, resolution.y - 1.0f, resolution.z - 1.0f };
+
+    auto num_nodes = resolution.x * resolution.y * resolution.z;
+    vx.resize(num_nodes);
+    vy.resize(num_nodes);
+    vz.resize(num_nodes);
+    next_vx.resize(num_nodes);
+    next_vy.resize(num_nodes);
+    next_vz.resize(num_nodes);
+
+    // start from the turbulent flow itself, instead of still air that slowly picks up speed
+    for (auto z = 0; z < resolution.z; z++) {
+        for (auto y = 0; y < resolution.y; y++) {
+            for (auto x = 0; x < resolution.x; x++) {
+                auto velocity = target_velocity(node_position(x, y, z));
+                auto i        = index(x, y, z);
+                vx[i] = velocity.x;
+                vy[i] = velocity.y;
+                vz[i] = velocity.z;
+            }
+        }
+    }
+
+    // split the z slices as evenly as possible. there are never more ranges than slices, so none of them is empty
+    auto num_ranges = std::min((int) num_threads, resolution.z);
+    first_range_end = resolution.z / num_ranges;
+    workers.reserve(num_ranges - 1);
+    for (auto r = 1; r < num_ranges; r++) {
+        workers.emplace_back(&WindField::work, this, r * resolution.z / num_ranges, (r + 1) * resolution.z / num_ranges);
+    }
+}
+
+WindField::~WindField() {
+    {
+        std::lock_guard lock{ mutex };
+        stopping = true;
+    }
+    update_started.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WindField::update(float time_step) {
+    // the workers only read the current velocities and each one writes its own part of the next velocities, so the
+    // only synchronization needed is starting them and waiting for them
+    {
+        std::lock_guard lock{ mutex };
+        current_time_step = time_step;
+        busy_workers      = (int) workers.size();
+        generation++;
+    }
+    update_started.notify_all();
+
+    // the calling thread takes the first range instead of waiting idly
+    update_slices(0, first_range_end, time_step);
+    {
+        std::unique_lock lock{ mutex };
+        update_finished.wait(lock, [this] { return busy_workers == 0; });
+    }
+
+    vx.swap(next_vx);
+    vy.swap(next_vy);
+    vz.swap(next_vz);
+    time += time_step;
+}
+
+void WindField::work(int z_begin, int z_end) {
+    auto seen_generation = 0u;
+    while (true) {
+        float time_step;
+        {
+            std::unique_lock lock{ mutex };
+            update_started.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping) {
+                return;
+            }
+            seen_generation = generation;
+            time_step       = current_time_step;
+        }
+
+        update_slices(z_begin, z_end, time_step);
+
+        {
+            std::lock_guard lock{ mutex };
+            busy_workers--;
+        }
+        update_finished.notify_one();
+    }
+}
+
+void WindField::sample(WindSamples& samples) const {
+    trilinear_batch(samples.x.data(), samples.y.data(), samples.z.data(), vx.data(), vy.data(), vz.data(),
+                    samples.vx.data(), samples.vy.data(), samples.vz.data(), samples.size(), origin, spacing, resolution);
+}
+
+glm::vec3 WindField::sample(glm::vec3 point) const {
+    auto g = (point - origin) / spacing;
+    g = glm::clamp(g, glm::vec3{ 0.0f }, glm::vec3{ resolution.x - 1.0f, resolution.y - 1.0f, resolution.z - 1.0f });
+
+    auto ix = std::min((int) g.x, resolution.x - 2);
+    auto iy = std::min((int) g.y, resolution.y - 2);
+    auto iz = std::min((int) g.z, resolution.z - 2);
+
+    auto tx   = g.x - ix;
+    auto ty   = g.y - iy;
+    auto tz   = g.z - iz;
+    auto sy   = resolution.x;
+    auto sz   = resolution.x * resolution.y;
+    auto cell = ix + iy * sy + iz * sz;
+
+    return { trilinear(vx.data(), cell, sy, sz, tx, ty, tz),
+             trilinear(vy.data(), cell, sy, sz, tx, ty, tz),
+             trilinear(vz.data(), cell, sy, sz, tx, ty, tz) };
+}
+
+glm::vec3 WindField::node_position(int x, int y, int z) const {
+    return origin + glm::vec3{ (float) x, (float) y, (float) z } * spacing;
+}
+
+int WindField::index(int x, int y, int z) const {
+    return x + (y + z * resolution.y) * resolution.x;
+}
+
+void WindField::update_slices(int z_begin, int z_end, float time_step) {
+    auto blend = std::min(relaxation * time_step, 1.0f);
+    for (auto z = z_begin; z < z_end; z++) {
+        for (auto y = 0; y < resolution.y; y++) {
+            for (auto x = 0; x < resolution.x; x++) {
+                auto i        = index(x, y, z);
+                auto position = node_position(x, y, z);
+                // semi-Lagrangian advection: the new velocity is the one found where this node's air came from
+                auto advected = sample(position - glm::vec3{ vx[i], vy[i], vz[i] } * time_step);
+                auto velocity = glm::mix(advected, target_velocity(position), blend);
+                next_vx[i] = velocity.x;
+                next_vy[i] = velocity.y;
+                next_vz[i] = velocity.z;
+            }
+        }
+    }
+}
+
+glm::vec3 WindField::target_velocity(glm::vec3 point) const {
+    // the noise pattern drifts along with the wind and slowly changes over time
+    auto p     = (point - direction * time) / noise_scale + glm::vec3{ 0.0f, 0.0f, time * noise_speed };
+    auto speed = glm::length(direction);
+
+    // two octaves of noise, with an independent noise for each component
+    glm::vec3 noise{ value_noise(p, 1u), value_noise(p, 2u), value_noise(p, 3u) };
+    noise += glm::vec3{ value_noise(p * 2.0f, 4u), value_noise(p * 2.0f, 5u), value_noise(p * 2.0f, 6u) } * 0.5f;
+    return direction + noise * speed * turbulence;
+}
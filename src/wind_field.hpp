@@ -0,0 +1,98 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a batch of points at which the wind field is sampled, stored as separate arrays per component
+// so that the sampling loop can be vectorized
+struct WindSamples {
+    void resize(std::size_t size);
+
+    std::size_t size() const;
+
+    // the positions at which to sample
+    std::vector<float> x, y, z;
+    // the sampled velocities
+    std::vector<float> vx, vy, vz;
+};
+
+// a 3D grid of wind velocities covering a box in world space
+// each update advects the velocities through themselves and pulls them towards a turbulent flow made of noise
+struct WindField {
+    WindField(glm::vec3 _origin, glm::vec3 _size, glm::ivec3 _resolution, glm::vec3 _direction, float _turbulence,
+              unsigned int _num_threads = 0);
+
+    // the worker threads point back to the field, so it can't be copied or moved
+    WindField(const WindField&) = delete;
+
+    WindField& operator=(const WindField&) = delete;
+
+    // stops and joins the worker threads
+    ~WindField();
+
+    // advances the field by the given time step, splitting the grid between the calling thread and the workers
+    void update(float time_step);
+
+    // trilinearly interpolates the velocities at all the positions in the batch, in a single pass
+    // points outside of the box get the velocity at the closest point of the box
+    void sample(WindSamples& samples) const;
+
+    // trilinearly interpolates the velocity at a single point
+    glm::vec3 sample(glm::vec3 point) const;
+
+    // world space position of the grid node (x, y, z)
+    glm::vec3 node_position(int x, int y, int z) const;
+
+    int index(int x, int y, int z) const;
+
+    // computes the new velocities of the nodes whose z coordinate is in [z_begin, z_end)
+    void update_slices(int z_begin, int z_end, float time_step);
+
+    // what each worker thread runs: waits for an update to start, does its slices, and reports back
+    void work(int z_begin, int z_end);
+
+    // the turbulent flow the field is pulled towards, at the given position and time
+    glm::vec3 target_velocity(glm::vec3 point) const;
+
+    glm::vec3  origin;
+    glm::vec3  size;
+    glm::ivec3 resolution;
+    // distance between two neighbouring nodes on each axis
+    glm::vec3  spacing;
+
+    // the mean direction of the wind. its length is the wind speed
+    glm::vec3 direction;
+    // how strong the noise is compared to the wind speed
+    float     turbulence;
+    float     time;
+
+    unsigned int num_threads;
+
+    // the workers are started once and kept around, since the updates are too small to pay for starting threads
+    // each one owns a fixed, non empty range of z slices. the calling thread of update does the first range
+    std::vector<std::thread> workers;
+    int                      first_range_end;
+    std::mutex               mutex;
+    std::condition_variable  update_started, update_finished;
+    // incremented for each update, so the workers know when a new one starts
+    unsigned int             generation;
+    // how many workers are still busy with the current update
+    int                      busy_workers;
+    float                    current_time_step;
+    bool                     stopping;
+
+    // the velocities of the nodes, one array per component. the next arrays are written while the current ones are read
+    std::vector<float> vx, vy, vz;
+    std::vector<float> next_vx, next_vy, next_vz;
+
+    // how fast the velocities are pulled towards the noise flow, per second
+    static constexpr float relaxation  = 2.0f;
+    // the size of the biggest turbulent eddies, in world units
+    static constexpr float noise_scale = 4.0f;
+    // how fast the noise pattern changes, per second
+    static constexpr float noise_speed = 0.5f;
+};